@@ -0,0 +1,148 @@
+/* hidhelper_uapi.h - 内核模块与用户态工具共享的接口定义 */
+#ifndef _HIDHELPER_UAPI_H
+#define _HIDHELPER_UAPI_H
+
+/*
+ * 只使用 stdint 类型：内核的 <linux/types.h> 同样提供这些类型，而用户态
+ * 不依赖 <linux/types.h>/<asm/types.h>（部分 32 位工具链没有）。
+ */
+#ifdef __KERNEL__
+#include <linux/types.h>
+#include <linux/ioctl.h>
+#else
+#include <stdint.h>
+#endif
+
+/* 操作模式（状态页 current_mode、CFG_F_MODE 使用） */
+#define MODE_CURSOR           0
+#define MODE_VIEW             1
+#define MODE_JOYSTICK         2
+#define MODE_SILENT           3     /* 静默模式，不产生输入 */
+
+/* ==================== 只读状态页 ==================== */
+
+/* mmap /dev/hidhelper（offset 0，PROT_READ）即可无系统调用采样 */
+#define STATUS_PAGE_VERSION   2
+
+/*
+ * 布局固定，写者在更新前后各递增一次 seq。用户态按以下方式无锁读取：
+ *   for (;;) {
+ *       s = READ_ONCE(page->seq);
+ *       if (s & 1) {                // 内核正在更新，重试
+ *           cpu_relax();
+ *           continue;
+ *       }
+ *       rmb();
+ *       snapshot = *page;
+ *       rmb();
+ *       if (READ_ONCE(page->seq) == s)
+ *           break;                  // 期间没有更新，快照一致
+ *   }
+ */
+struct stealth_status_page {
+    uint32_t seq;                      /* 奇数表示正在写入 */
+    uint32_t version;
+    int32_t activated;
+    int32_t current_mode;
+    uint32_t active_slots;             /* 当前按下的触点位图 */
+    int32_t joystick_active;
+    int32_t joystick_x;
+    int32_t joystick_y;
+    uint64_t update_ns;                /* 最近一次更新（CLOCK_MONOTONIC） */
+    uint64_t stats_moves;
+    uint64_t stats_clicks;
+    uint64_t stats_slides;
+    uint64_t stats_commands;
+    uint64_t stats_dropped;            /* v2 */
+};
+
+/* ==================== ioctl ABI ==================== */
+
+/* 固定布局结构 + 字段掩码，可一次更新任意字段子集 */
+#define STEALTH_IOC_MAGIC       'Q'
+#define STEALTH_IOC_ABI_VERSION 1
+
+/* 轮盘字段掩码（位序与 CMD_SET_JOYSTICK 的字段顺序一致） */
+#define JOY_F_CENTER_X        (1U << 0)
+#define JOY_F_CENTER_Y        (1U << 1)
+#define JOY_F_RADIUS          (1U << 2)
+#define JOY_F_DEADZONE        (1U << 3)
+#define JOY_F_MOVE_SLOT       (1U << 4)
+#define JOY_F_ENABLED         (1U << 5)
+#define JOY_F_ALL             0x3FU
+
+/* 滑动键字段掩码（位序与 CMD_SET_SLIDE_KEY 的字段顺序一致） */
+#define SLIDE_F_ENABLED       (1U << 0)
+#define SLIDE_F_TRIGGER_KEY   (1U << 1)
+#define SLIDE_F_SLIDE_X       (1U << 2)
+#define SLIDE_F_SLIDE_Y       (1U << 3)
+#define SLIDE_F_MAX_RADIUS    (1U << 4)
+#define SLIDE_F_SENSITIVITY   (1U << 5)
+#define SLIDE_F_HOLD_TIME     (1U << 6)
+#define SLIDE_F_RELEASE_DELAY (1U << 7)
+#define SLIDE_F_ALL           0xFFU
+
+/* 通用配置字段掩码 */
+#define CFG_F_MODE            (1U << 0)
+#define CFG_F_JITTER          (1U << 1)
+#define CFG_F_SENSITIVITY     (1U << 2)
+#define CFG_F_HEARTBEAT       (1U << 3)
+#define CFG_F_ALL             0x0FU
+
+/* ioctl 参数结构（均为 32 位字段，32/64 位用户态布局一致） */
+struct stealth_ioc_joystick {
+    uint32_t abi_version;              /* 必须为 STEALTH_IOC_ABI_VERSION */
+    uint32_t mask;                     /* JOY_F_* */
+    int32_t center_x;
+    int32_t center_y;
+    int32_t radius;
+    int32_t deadzone;
+    int32_t move_slot;
+    int32_t enabled;
+};
+
+struct stealth_ioc_slide_key {
+    uint32_t abi_version;
+    uint32_t mask;                     /* SLIDE_F_* */
+    int32_t enabled;
+    int32_t trigger_key;
+    int32_t slide_x;
+    int32_t slide_y;
+    int32_t max_radius;
+    int32_t sensitivity;
+    int32_t hold_time;
+    int32_t release_delay;
+};
+
+struct stealth_ioc_config {
+    uint32_t abi_version;
+    uint32_t mask;                     /* CFG_F_* */
+    int32_t current_mode;
+    int32_t jitter_range;
+    int32_t sensitivity;
+    int32_t heartbeat_interval;
+};
+
+#ifdef _IOW
+#define STEALTH_IO(nr)            _IO(STEALTH_IOC_MAGIC, nr)
+#define STEALTH_IOR(nr, type)     _IOR(STEALTH_IOC_MAGIC, nr, type)
+#define STEALTH_IOW(nr, type)     _IOW(STEALTH_IOC_MAGIC, nr, type)
+#else
+/* 未包含 <sys/ioctl.h> 时按 asm-generic 编码（arm/arm64/x86 与内核一致） */
+#define STEALTH_IOC_ENC(dir, nr, size) \
+    (((dir) << 30) | ((uint32_t)(size) << 16) | \
+     ((uint32_t)STEALTH_IOC_MAGIC << 8) | (uint32_t)(nr))
+#define STEALTH_IO(nr)            STEALTH_IOC_ENC(0U, nr, 0)
+#define STEALTH_IOR(nr, type)     STEALTH_IOC_ENC(2U, nr, sizeof(type))
+#define STEALTH_IOW(nr, type)     STEALTH_IOC_ENC(1U, nr, sizeof(type))
+#endif
+
+#define STEALTH_IOC_GET_VERSION   STEALTH_IOR(0, uint32_t)
+#define STEALTH_IOC_SET_JOYSTICK  STEALTH_IOW(1, struct stealth_ioc_joystick)
+#define STEALTH_IOC_SET_SLIDE_KEY STEALTH_IOW(2, struct stealth_ioc_slide_key)
+#define STEALTH_IOC_SET_CONFIG    STEALTH_IOW(3, struct stealth_ioc_config)
+#define STEALTH_IOC_ACTIVATE      STEALTH_IO(4)
+#define STEALTH_IOC_DEACTIVATE    STEALTH_IO(5)
+#define STEALTH_IOC_HEARTBEAT     STEALTH_IO(6)
+
+#endif /* _HIDHELPER_UAPI_H */
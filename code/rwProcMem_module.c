@@ -38,6 +38,13 @@
 #include <linux/types.h>
 #include <linux/ktime.h>
 #include <linux/spinlock.h>
+#include <linux/mm.h>
+#include <linux/io.h>
+#include <linux/jump_label.h>
+#include <linux/suspend.h>
+#include <net/genetlink.h>
+
+#include "hidhelper_uapi.h"
 
 #define DRIVER_NAME "qc_hid_helper"
 #define DEVICE_NAME "hidhelper"
@@ -47,6 +54,7 @@
 // 隐蔽通信机制
 #define MAGIC_SIGNATURE 0x51444953  // "QDIS"
 #define CMD_CHANNEL_NUM 5           // 多个命令通道增加隐蔽性
+#define MAX_TOUCH_SLOTS 10          // 与 ABS_MT_SLOT 范围一致
 
 // 命令类型
 #define CMD_SET_SLIDE_KEY     0xA1
@@ -60,11 +68,36 @@
 #define CMD_DEACTIVATE        0xA9
 #define CMD_HEARTBEAT         0xAA
 
-// 操作模式
-#define MODE_CURSOR           0
-#define MODE_VIEW             1
-#define MODE_JOYSTICK         2
-#define MODE_SILENT           3     // 静默模式，不产生输入
+// Generic Netlink 接口（与字符设备命令相同，另提供事件广播）
+#define STEALTH_GENL_NAME     "qc_hid"
+#define STEALTH_GENL_VERSION  1
+#define STEALTH_GENL_MCGRP    "events"
+
+// genl 命令
+#define STEALTH_GENL_CMD_UNSPEC      0
+#define STEALTH_GENL_CMD_EXEC        1  // 执行 CMD_* 命令（A_CMD + A_PAYLOAD）
+#define STEALTH_GENL_CMD_GET_STATUS  2  // 返回当前状态
+#define STEALTH_GENL_CMD_EVENT       3  // 仅用于多播通知
+#define STEALTH_GENL_CMD_MAX         STEALTH_GENL_CMD_EVENT
+
+// genl 属性
+#define STEALTH_GENL_A_UNSPEC        0
+#define STEALTH_GENL_A_CMD           1  // u8, CMD_*
+#define STEALTH_GENL_A_PAYLOAD       2  // binary, 与字符设备 cmd 之后的 payload 相同
+#define STEALTH_GENL_A_EVENT         3  // u8, EVT_*
+#define STEALTH_GENL_A_ACTIVATED     4  // u8
+#define STEALTH_GENL_A_MODE          5  // u32
+#define STEALTH_GENL_A_STATS_MOVES   6  // u64
+#define STEALTH_GENL_A_STATS_CMDS    7  // u64
+#define STEALTH_GENL_A_STATS_DROPPED 8  // u64
+#define STEALTH_GENL_A_MAX           STEALTH_GENL_A_STATS_DROPPED
+
+// 多播事件类型
+#define EVT_ACTIVATED         1
+#define EVT_DEACTIVATED       2
+#define EVT_HEARTBEAT_EXPIRED 3
+#define EVT_MODE_CHANGED      4
+#define EVT_PROFILE_CHANGED   5
 
 // 配置结构
 struct stealth_config {
@@ -186,6 +219,7 @@ struct stealth_config {
     unsigned long stats_clicks;
     unsigned long stats_slides;
     unsigned long stats_commands;
+    unsigned long stats_dropped;    // 被合并丢弃的中间移动
 };
 
 // 设备结构
@@ -213,15 +247,45 @@ struct stealth_device {
         unsigned short crc;
     } cmd_channels[CMD_CHANNEL_NUM];
     
-    // 定时器用于心跳和清理
+    // 定时器用于心跳和清理（仅在激活期间运行）
     struct timer_list heartbeat_timer;
+    struct work_struct deactivate_work;     // 心跳超时后在进程上下文中完成停用
+    
+    // 系统休眠期间暂停定时器/工作线程，唤醒后顺延心跳期限
+    struct notifier_block pm_nb;
+    int pm_registered;
+    int suspended;
+    unsigned long suspend_time;
     
     // 隐蔽标识
     unsigned char hidden_id[16];
+    
+    // Generic Netlink 是否注册成功
+    int genl_registered;
+    
+    // 只读状态页（写者由 config_lock 串行化）
+    struct stealth_status_page *status_page;
+    unsigned long active_slots;
+    
+    /*
+     * 待发送触点更新：每个 slot 最多一项，只保留最新位置。
+     * 队列长度上限为 MAX_TOUCH_SLOTS，下游跟不上时丢弃中间移动而非排队。
+     */
+    struct {
+        int x;
+        int y;
+        int pressure;
+    } pending[MAX_TOUCH_SLOTS];
+    unsigned long pending_mask;
+    spinlock_t pending_lock;
+    struct work_struct flush_work;
 };
 
 static struct stealth_device *stealth_dev;
 
+/* 未激活时逐事件路径只剩一条被 patch 掉的跳转指令 */
+static DEFINE_STATIC_KEY_FALSE(stealth_active_key);
+
 /* 避免与内核已有 clamp 宏冲突，使用局部函数 */
 static inline int stealth_clamp(int val, int min, int max)
 {
@@ -293,14 +357,186 @@ static void generate_hidden_id(unsigned char *id, int len)
     id[3] ^= ts.tv_sec & 0xFF;
 }
 
+// ==================== 状态页 ====================
+/* 调用者须持有 config_lock */
+static void stealth_publish_status_locked(void)
+{
+    struct stealth_status_page *sp = stealth_dev->status_page;
+    struct stealth_config *cfg = &stealth_dev->config;
+    
+    if (!sp)
+        return;
+    
+    WRITE_ONCE(sp->seq, sp->seq + 1);
+    smp_wmb();
+    
+    sp->activated = cfg->activated;
+    sp->current_mode = cfg->current_mode;
+    sp->active_slots = (__u32)stealth_dev->active_slots;
+    sp->joystick_active = cfg->joystick.active;
+    sp->joystick_x = cfg->joystick.current_x;
+    sp->joystick_y = cfg->joystick.current_y;
+    sp->update_ns = ktime_get_ns();
+    sp->stats_moves = cfg->stats_moves;
+    sp->stats_clicks = cfg->stats_clicks;
+    sp->stats_slides = cfg->stats_slides;
+    sp->stats_commands = cfg->stats_commands;
+    sp->stats_dropped = cfg->stats_dropped;
+    
+    smp_wmb();
+    WRITE_ONCE(sp->seq, sp->seq + 1);
+}
+
+static void stealth_publish_status(void)
+{
+    unsigned long flags;
+    
+    spin_lock_irqsave(&stealth_dev->config_lock, flags);
+    stealth_publish_status_locked();
+    spin_unlock_irqrestore(&stealth_dev->config_lock, flags);
+}
+
+// ==================== 事件通知 ====================
+static struct genl_family stealth_genl_family;
+
+/* 可在 timer 等原子上下文调用；无订阅者时直接返回 */
+static void stealth_notify_event(int event, int activated, int mode)
+{
+    struct sk_buff *skb;
+    void *hdr;
+    
+    if (!stealth_dev || !stealth_dev->genl_registered)
+        return;
+    
+    if (!genl_has_listeners(&stealth_genl_family, &init_net, 0))
+        return;
+    
+    skb = genlmsg_new(2 * nla_total_size(sizeof(u8)) +
+                      nla_total_size(sizeof(u32)), GFP_ATOMIC);
+    if (!skb)
+        return;
+    
+    hdr = genlmsg_put(skb, 0, 0, &stealth_genl_family, 0,
+                      STEALTH_GENL_CMD_EVENT);
+    if (!hdr)
+        goto fail;
+    
+    if (nla_put_u8(skb, STEALTH_GENL_A_EVENT, event) ||
+        nla_put_u8(skb, STEALTH_GENL_A_ACTIVATED, !!activated) ||
+        nla_put_u32(skb, STEALTH_GENL_A_MODE, mode))
+        goto fail;
+    
+    genlmsg_end(skb, hdr);
+    genlmsg_multicast(&stealth_genl_family, skb, 0, 0, GFP_ATOMIC);
+    return;
+    
+fail:
+    nlmsg_free(skb);
+}
+
 // ==================== 输入事件处理 ====================
+/* 发出单个 slot 的触摸事件（不含 input_sync），调用者持有 pending_lock */
+static void emit_touch_locked(struct input_dev *dev, int slot,
+                              int x, int y, int pressure)
+{
+    // 发送触摸事件（兼容GKI）
+    input_mt_slot(dev, slot);
+    input_mt_report_slot_state(dev, MT_TOOL_FINGER, pressure > 0);
+    
+    if (pressure > 0) {
+        input_report_abs(dev, ABS_MT_POSITION_X, x);
+        input_report_abs(dev, ABS_MT_POSITION_Y, y);
+        input_report_abs(dev, ABS_MT_PRESSURE, pressure);
+        input_report_abs(dev, ABS_MT_TOUCH_MAJOR, 10);
+        input_report_abs(dev, ABS_MT_TRACKING_ID, slot);
+        __set_bit(slot, &stealth_dev->active_slots);
+    } else {
+        input_report_abs(dev, ABS_MT_TRACKING_ID, -1);
+        __clear_bit(slot, &stealth_dev->active_slots);
+    }
+    
+    stealth_dev->config.stats_moves++;
+}
+
+/* 一次性发出所有待发送的 slot，合并为一帧 */
+static void stealth_flush_work(struct work_struct *work)
+{
+    struct input_dev *dev = stealth_dev->input_dev;
+    unsigned long flags;
+    int slot;
+    
+    spin_lock_irqsave(&stealth_dev->pending_lock, flags);
+    
+    if (dev && stealth_dev->pending_mask) {
+        for_each_set_bit(slot, &stealth_dev->pending_mask, MAX_TOUCH_SLOTS) {
+            emit_touch_locked(dev, slot,
+                              stealth_dev->pending[slot].x,
+                              stealth_dev->pending[slot].y,
+                              stealth_dev->pending[slot].pressure);
+        }
+        stealth_dev->pending_mask = 0;
+        input_sync(dev);
+    }
+    
+    spin_unlock_irqrestore(&stealth_dev->pending_lock, flags);
+    
+    stealth_publish_status();
+}
+
+/*
+ * 停用/休眠前清空合并队列（可睡眠）：先发出所有待发送更新（包括抬起），
+ * 再抬起仍处于按下状态的 slot，避免停用后触点卡在输入子系统中。
+ */
+static void stealth_drain_pending(void)
+{
+    struct input_dev *dev = stealth_dev->input_dev;
+    unsigned long flags;
+    int slot;
+    
+    spin_lock_irqsave(&stealth_dev->pending_lock, flags);
+    
+    if (dev) {
+        for_each_set_bit(slot, &stealth_dev->pending_mask, MAX_TOUCH_SLOTS) {
+            emit_touch_locked(dev, slot,
+                              stealth_dev->pending[slot].x,
+                              stealth_dev->pending[slot].y,
+                              stealth_dev->pending[slot].pressure);
+        }
+        for_each_set_bit(slot, &stealth_dev->active_slots, MAX_TOUCH_SLOTS) {
+            emit_touch_locked(dev, slot, 0, 0, 0);
+        }
+        input_sync(dev);
+    }
+    stealth_dev->pending_mask = 0;
+    
+    spin_unlock_irqrestore(&stealth_dev->pending_lock, flags);
+    
+    /* 在清空之后取消：之前已排队的 work 只会看到空队列 */
+    cancel_work_sync(&stealth_dev->flush_work);
+    
+    /* 所有 slot 已抬起，同步清除轮盘/光标的按下状态（调用者持有 lock） */
+    stealth_dev->config.joystick.active = 0;
+    stealth_dev->config.joystick.key_states = 0;
+    stealth_dev->config.cursor.active = 0;
+    
+    stealth_publish_status();
+}
+
 static void send_touch_event_safe(int slot, int x, int y, int pressure)
 {
     struct input_dev *dev = stealth_dev->input_dev;
+    unsigned long flags;
+    int flushed = 0;
+    
+    if (!static_branch_unlikely(&stealth_active_key))
+        return;
     
     if (!dev || !stealth_dev->config.activated)
         return;
     
+    if (slot < 0 || slot >= MAX_TOUCH_SLOTS)
+        return;
+    
     // 边界检查
     x = stealth_clamp(x, 0, stealth_dev->config.screen_width - 1);
     y = stealth_clamp(y, 0, stealth_dev->config.screen_height - 1);
@@ -324,22 +560,52 @@ static void send_touch_event_safe(int slot, int x, int y, int pressure)
         y = stealth_clamp(y, 0, stealth_dev->config.screen_height - 1);
     }
     
-    // 发送触摸事件（兼容GKI）
-    input_mt_slot(dev, slot);
-    input_mt_report_slot_state(dev, MT_TOOL_FINGER, pressure > 0);
+    spin_lock_irqsave(&stealth_dev->pending_lock, flags);
     
-    if (pressure > 0) {
-        input_report_abs(dev, ABS_MT_POSITION_X, x);
-        input_report_abs(dev, ABS_MT_POSITION_Y, y);
-        input_report_abs(dev, ABS_MT_PRESSURE, pressure);
-        input_report_abs(dev, ABS_MT_TOUCH_MAJOR, 10);
-        input_report_abs(dev, ABS_MT_TRACKING_ID, slot);
-    } else {
-        input_report_abs(dev, ABS_MT_TRACKING_ID, -1);
+    /*
+     * 停用或休眠准备开始后不再入队：activated 清零 / suspended 置位都发生在
+     * stealth_drain_pending() 取 pending_lock 之前，锁外的检查可能已过时，
+     * 因此在锁内重新检查，保证清空后不会再排队 flush_work。
+     */
+    if (!READ_ONCE(stealth_dev->config.activated) ||
+        READ_ONCE(stealth_dev->suspended)) {
+        spin_unlock_irqrestore(&stealth_dev->pending_lock, flags);
+        return;
     }
     
-    input_sync(dev);
-    stealth_dev->config.stats_moves++;
+    if (test_bit(slot, &stealth_dev->pending_mask)) {
+        int old_pressure = stealth_dev->pending[slot].pressure;
+        
+        /*
+         * 只合并同类更新：已按下 slot 上的连续移动，或重复的抬起。
+         * 按下/抬起的切换不能丢，先把旧值立即发出去。
+         */
+        if ((old_pressure > 0 && pressure > 0 &&
+             test_bit(slot, &stealth_dev->active_slots)) ||
+            (old_pressure == 0 && pressure == 0)) {
+            stealth_dev->config.stats_dropped++;
+        } else {
+            emit_touch_locked(dev, slot,
+                              stealth_dev->pending[slot].x,
+                              stealth_dev->pending[slot].y,
+                              old_pressure);
+            input_sync(dev);
+            flushed = 1;
+        }
+    }
+    
+    stealth_dev->pending[slot].x = x;
+    stealth_dev->pending[slot].y = y;
+    stealth_dev->pending[slot].pressure = pressure;
+    __set_bit(slot, &stealth_dev->pending_mask);
+    
+    /* 已排队时 queue_work 直接返回，不会堆积 */
+    queue_work(system_highpri_wq, &stealth_dev->flush_work);
+    
+    spin_unlock_irqrestore(&stealth_dev->pending_lock, flags);
+    
+    if (flushed)
+        stealth_publish_status();
 }
 
 // ==================== 轮盘处理 ====================
@@ -419,9 +685,16 @@ static void handle_key_mapping(int keycode, int pressed)
 {
     struct stealth_config *cfg = &stealth_dev->config;
     
+    if (!static_branch_unlikely(&stealth_active_key))
+        return;
+    
     // 模式切换键
     if (keycode == cfg->mode_switch_key && pressed) {
         cfg->current_mode = (cfg->current_mode + 1) % 4;
+        stealth_publish_status();
+        /* 注意：handle_key_mapping 目前没有调用者，接入按键事件源后此通知才会生效 */
+        stealth_notify_event(EVT_MODE_CHANGED, cfg->activated,
+                             cfg->current_mode);
         return;
     }
     
@@ -476,40 +749,119 @@ static void handle_key_mapping(int keycode, int pressed)
     }
 }
 
-// ==================== 隐蔽命令处理 ====================
+// ==================== 配置更新 ====================
+/* 以下 apply 函数由调用者持有 stealth_dev->lock，仅更新 mask 中的字段 */
+static void stealth_apply_joystick(const struct stealth_ioc_joystick *j)
+{
+    struct stealth_config *cfg = &stealth_dev->config;
+    
+    if (j->mask & JOY_F_CENTER_X)  cfg->joystick.center_x = j->center_x;
+    if (j->mask & JOY_F_CENTER_Y)  cfg->joystick.center_y = j->center_y;
+    if (j->mask & JOY_F_RADIUS)    cfg->joystick.radius = j->radius;
+    if (j->mask & JOY_F_DEADZONE)  cfg->joystick.deadzone = j->deadzone;
+    if (j->mask & JOY_F_MOVE_SLOT) cfg->joystick.move_slot = j->move_slot;
+    if (j->mask & JOY_F_ENABLED)   cfg->joystick.enabled = j->enabled;
+}
+
+static void stealth_apply_slide_key(const struct stealth_ioc_slide_key *k)
+{
+    struct stealth_config *cfg = &stealth_dev->config;
+    
+    if (k->mask & SLIDE_F_ENABLED)       cfg->slide_key.enabled = k->enabled;
+    if (k->mask & SLIDE_F_TRIGGER_KEY)   cfg->slide_key.trigger_key = k->trigger_key;
+    if (k->mask & SLIDE_F_SLIDE_X)       cfg->slide_key.slide_x = k->slide_x;
+    if (k->mask & SLIDE_F_SLIDE_Y)       cfg->slide_key.slide_y = k->slide_y;
+    if (k->mask & SLIDE_F_MAX_RADIUS)    cfg->slide_key.max_radius = k->max_radius;
+    if (k->mask & SLIDE_F_SENSITIVITY)   cfg->slide_key.sensitivity = k->sensitivity;
+    if (k->mask & SLIDE_F_HOLD_TIME)     cfg->slide_key.hold_time = k->hold_time;
+    if (k->mask & SLIDE_F_RELEASE_DELAY) cfg->slide_key.release_delay = k->release_delay;
+}
+
 /*
- * 协议假定：
- * 0..3  - magic (u32 LE)
- * 4..5  - crc   (u16 LE)
- * 6     - cmd   (u8)
- * 7..   - payload (命令相关，可变长度)
- *
- * 对每个字段读取前都检查缓冲区长度，以避免未对齐/越界读取。
+ * 旧协议的可变长度字段序列（均为 u32 LE）：缓冲区包含几个字段就读取几个，
+ * 返回对应的前缀掩码。
  */
-static int process_hidden_command(unsigned char *data, int len)
+static u32 parse_field_prefix(const unsigned char *payload, int plen,
+                              s32 *vals, int nvals)
 {
-    const int hdr_min_len = 7; /* 0..6 inclusive */
-    unsigned int magic_val;
-    unsigned short crc_val;
-    unsigned short crc_calc;
-    unsigned char cmd;
-    int ret = 0;
+    u32 mask = 0;
+    int i;
+    
+    for (i = 0; i < nvals && (i + 1) * 4 <= plen; i++) {
+        vals[i] = (s32)get_unaligned_le32(payload + i * 4);
+        mask |= 1U << i;
+    }
+    return mask;
+}
 
-    if (!data || len < hdr_min_len)
-        return -EINVAL;
+/*
+ * 激活/停用的唯一入口（调用者持有 lock，可睡眠）。
+ * 停用时关闭 static key、删除心跳定时器并让工作线程休眠，
+ * 未激活的模块不再产生任何周期性唤醒或逐事件开销。
+ */
+static void stealth_set_active(int on)
+{
+    unsigned long flags;
+    
+    spin_lock_irqsave(&stealth_dev->config_lock, flags);
+    stealth_dev->config.activated = on;
+    if (on)
+        stealth_dev->config.activate_time = jiffies;
+    spin_unlock_irqrestore(&stealth_dev->config_lock, flags);
+    
+    if (on) {
+        static_branch_enable(&stealth_active_key);
+        /* 休眠准备期间收到的激活由 resume 负责启动定时器 */
+        if (!stealth_dev->suspended)
+            mod_timer(&stealth_dev->heartbeat_timer,
+                      jiffies + msecs_to_jiffies(1000));
+        wake_up(&stealth_dev->cmd_waitq);
+    } else {
+        static_branch_disable(&stealth_active_key);
+        del_timer_sync(&stealth_dev->heartbeat_timer);
+        stealth_drain_pending();
+    }
+}
 
-    /* 安全读取：使用 get_unaligned_leX 以避免未对齐访问，并明确小端字节序 */
-    magic_val = get_unaligned_le32(data);       /* 0..3 */
-    crc_val = get_unaligned_le16(data + 4);     /* 4..5 */
-    cmd = data[6];                              /* 6 */
+/* 命令成功后的统一收尾：统计、状态页、事件通知（调用者持有 lock） */
+static void stealth_command_done(int event)
+{
+    stealth_dev->config.stats_commands++;
+    stealth_publish_status();
+    
+    if (event)
+        stealth_notify_event(event, stealth_dev->config.activated,
+                             stealth_dev->config.current_mode);
+}
 
-    /* 验证魔术字 */
-    if (magic_val != MAGIC_SIGNATURE)
-        return -EINVAL;
+/*
+ * 通用配置更新的收尾（调用者持有 lock）：changed 为 CFG_F_* 掩码，
+ * 含 CFG_F_MODE 时发 EVT_MODE_CHANGED，含其他字段时发 EVT_PROFILE_CHANGED。
+ */
+static void stealth_config_done(u32 changed)
+{
+    stealth_command_done((changed & CFG_F_MODE) ? EVT_MODE_CHANGED
+                                                : EVT_PROFILE_CHANGED);
+    
+    if ((changed & CFG_F_MODE) && (changed & ~CFG_F_MODE))
+        stealth_notify_event(EVT_PROFILE_CHANGED,
+                             stealth_dev->config.activated,
+                             stealth_dev->config.current_mode);
+}
 
-    /* 验证 CRC: CRC 计算覆盖从 offset 6 开始的字节 (cmd + payload) */
-    crc_calc = simple_crc16(data + 6, len - 6);
-    if (crc_val != crc_calc)
+// ==================== 隐蔽命令处理 ====================
+/*
+ * 执行单条命令，字符设备与 Generic Netlink 共用。
+ * payload 为 cmd 之后的字节（命令相关，可变长度），每个字段读取前都检查长度。
+ */
+static int stealth_exec_command(unsigned char cmd, const unsigned char *payload,
+                                int plen)
+{
+    int ret = 0;
+    int event = 0;
+    u32 cfg_changed = 0;    /* 非零时按 CFG_F_* 规则发事件 */
+
+    if (!payload && plen > 0)
         return -EINVAL;
 
     mutex_lock(&stealth_dev->lock);
@@ -517,12 +869,13 @@ static int process_hidden_command(unsigned char *data, int len)
     switch (cmd) {
     case CMD_ACTIVATE:
         /* 无额外 payload */
-        stealth_dev->config.activated = 1;
-        stealth_dev->config.activate_time = jiffies;
+        stealth_set_active(1);
+        event = EVT_ACTIVATED;
         break;
 
     case CMD_DEACTIVATE:
-        stealth_dev->config.activated = 0;
+        stealth_set_active(0);
+        event = EVT_DEACTIVATED;
         break;
 
     case CMD_HEARTBEAT:
@@ -531,113 +884,105 @@ static int process_hidden_command(unsigned char *data, int len)
 
     case CMD_SET_CONFIG:
         /*
-         * 预期 payload (从 offset 7 开始):
+         * 预期 payload:
          *  - current_mode (u32 LE)
          *  - jitter_range (u32 LE)
-         * 要求最小总长度 >= 7 + 8 = 15
+         * 要求最小 payload 长度 >= 8
          */
-        if (len < 15) {
+        if (plen < 8) {
             ret = -EINVAL;
             break;
         }
         {
-            u32 mode_le = get_unaligned_le32(data + 7);
-            u32 jitter_le = get_unaligned_le32(data + 11);
+            u32 mode_le = get_unaligned_le32(payload);
+            u32 jitter_le = get_unaligned_le32(payload + 4);
             /* get_unaligned_le32 已返回 CPU 序整数（从 LE bytes），直接使用 */
             stealth_dev->config.current_mode = (int)mode_le;
             stealth_dev->config.jitter_range = (int)jitter_le;
         }
+        cfg_changed = CFG_F_MODE | CFG_F_JITTER;
         break;
 
     case CMD_SET_MODE:
         /*
-         * payload (offset 7):
+         * payload:
          *  - mode (u32 LE)
-         * minimal len = 7 + 4 = 11
+         * minimal plen = 4
          */
-        if (len < 11) {
+        if (plen < 4) {
             ret = -EINVAL;
             break;
         }
         {
-            u32 new_mode = get_unaligned_le32(data + 7);
+            u32 new_mode = get_unaligned_le32(payload);
             stealth_dev->config.current_mode = (int)new_mode;
         }
+        cfg_changed = CFG_F_MODE;
         break;
 
     case CMD_SET_SENSITIVITY:
         /*
-         * payload (offset 7):
+         * payload:
          *  - sensitivity (u32 LE)
-         * minimal len = 11
+         * minimal plen = 4
          */
-        if (len < 11) {
+        if (plen < 4) {
             ret = -EINVAL;
             break;
         }
         {
-            u32 sens = get_unaligned_le32(data + 7);
+            u32 sens = get_unaligned_le32(payload);
             /* 将灵敏度限制在合理范围 */
             stealth_dev->config.view.sensitivity = stealth_clamp((int)sens, 1, 10000);
         }
+        cfg_changed = CFG_F_SENSITIVITY;
         break;
 
     case CMD_SET_JOYSTICK:
         /*
-         * 轮盘可能带可变字段。采用“按需读取”策略：只有当缓冲区包含对应字段时才读取。
-         * 字段顺序（假定，均为 u32 LE）：
+         * 轮盘可能带可变字段，只有当缓冲区包含对应字段时才读取。
+         * 字段顺序（均为 u32 LE）：
          *   center_x, center_y, radius, deadzone, move_slot, enabled
          *
-         * 这允许 tools 只传递部分字段来更新子集配置。
+         * 只能更新字段前缀；任意子集请使用 STEALTH_IOC_SET_JOYSTICK。
          */
         {
-            int offset = 7;
-            u32 tmp;
-            if (offset + 4 <= len) {
-                tmp = get_unaligned_le32(data + offset); offset += 4;
-                stealth_dev->config.joystick.center_x = (int)tmp;
-            }
-            if (offset + 4 <= len) {
-                tmp = get_unaligned_le32(data + offset); offset += 4;
-                stealth_dev->config.joystick.center_y = (int)tmp;
-            }
-            if (offset + 4 <= len) {
-                tmp = get_unaligned_le32(data + offset); offset += 4;
-                stealth_dev->config.joystick.radius = (int)tmp;
-            }
-            if (offset + 4 <= len) {
-                tmp = get_unaligned_le32(data + offset); offset += 4;
-                stealth_dev->config.joystick.deadzone = (int)tmp;
-            }
-            if (offset + 4 <= len) {
-                tmp = get_unaligned_le32(data + offset); offset += 4;
-                stealth_dev->config.joystick.move_slot = (int)tmp;
-            }
-            if (offset + 4 <= len) {
-                tmp = get_unaligned_le32(data + offset); offset += 4;
-                stealth_dev->config.joystick.enabled = (int)tmp;
-            }
-            /* 若需要更多字段，可采用相同的“读前校验”方法 */
+            struct stealth_ioc_joystick j = { 0 };
+            s32 v[6] = { 0 };
+            
+            j.mask = parse_field_prefix(payload, plen, v, 6);
+            j.center_x = v[0];
+            j.center_y = v[1];
+            j.radius = v[2];
+            j.deadzone = v[3];
+            j.move_slot = v[4];
+            j.enabled = v[5];
+            stealth_apply_joystick(&j);
         }
+        event = EVT_PROFILE_CHANGED;
         break;
 
     case CMD_SET_SLIDE_KEY:
         /*
-         * slide key 也可能是可变字段序列。我们按字段依次读取（均为 u32 LE）。
-         * 字段（示例顺序）：enabled, trigger_key, slide_x, slide_y, max_radius, sensitivity, hold_time, release_delay
+         * slide key 也是可变字段序列（均为 u32 LE）：
+         * enabled, trigger_key, slide_x, slide_y, max_radius, sensitivity, hold_time, release_delay
          */
         {
-            int offset = 7;
-            u32 t;
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.enabled = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.trigger_key = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.slide_x = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.slide_y = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.max_radius = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.sensitivity = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.hold_time = (int)t; }
-            if (offset + 4 <= len) { t = get_unaligned_le32(data + offset); offset += 4; stealth_dev->config.slide_key.release_delay = (int)t; }
+            struct stealth_ioc_slide_key k = { 0 };
+            s32 v[8] = { 0 };
+            
+            k.mask = parse_field_prefix(payload, plen, v, 8);
+            k.enabled = v[0];
+            k.trigger_key = v[1];
+            k.slide_x = v[2];
+            k.slide_y = v[3];
+            k.max_radius = v[4];
+            k.sensitivity = v[5];
+            k.hold_time = v[6];
+            k.release_delay = v[7];
+            stealth_apply_slide_key(&k);
         }
+        event = EVT_PROFILE_CHANGED;
         break;
 
     case CMD_SET_KEY_MAPPING:
@@ -646,8 +991,8 @@ static int process_hidden_command(unsigned char *data, int len)
          * 更安全的做法是：由 userspace 在解析后通过受控接口（例如 ioctl 或 sysfs）按单个 mapping 项逐一提交。
          * 在此处我们仅接受简单的“启用/禁用”或长度足够时读取几个固定字段示例。
          */
-        if (len >= 11) {
-            u32 simple_flag = get_unaligned_le32(data + 7);
+        if (plen >= 4) {
+            u32 simple_flag = get_unaligned_le32(payload);
             /* simple_flag 用于演示：非零表示启用某行为 */
             /* 这里仅记录统计或用于触发简单行为 */
             if (simple_flag)
@@ -664,13 +1009,52 @@ static int process_hidden_command(unsigned char *data, int len)
         break;
     }
 
-    if (ret == 0)
-        stealth_dev->config.stats_commands++;
+    if (ret == 0 && cfg_changed)
+        stealth_config_done(cfg_changed);
+    else if (ret == 0)
+        stealth_command_done(event);
 
     mutex_unlock(&stealth_dev->lock);
     return ret;
 }
 
+/*
+ * 协议假定：
+ * 0..3  - magic (u32 LE)
+ * 4..5  - crc   (u16 LE)
+ * 6     - cmd   (u8)
+ * 7..   - payload (命令相关，可变长度)
+ *
+ * 对每个字段读取前都检查缓冲区长度，以避免未对齐/越界读取。
+ */
+static int process_hidden_command(unsigned char *data, int len)
+{
+    const int hdr_min_len = 7; /* 0..6 inclusive */
+    unsigned int magic_val;
+    unsigned short crc_val;
+    unsigned short crc_calc;
+    unsigned char cmd;
+
+    if (!data || len < hdr_min_len)
+        return -EINVAL;
+
+    /* 安全读取：使用 get_unaligned_leX 以避免未对齐访问，并明确小端字节序 */
+    magic_val = get_unaligned_le32(data);       /* 0..3 */
+    crc_val = get_unaligned_le16(data + 4);     /* 4..5 */
+    cmd = data[6];                              /* 6 */
+
+    /* 验证魔术字 */
+    if (magic_val != MAGIC_SIGNATURE)
+        return -EINVAL;
+
+    /* 验证 CRC: CRC 计算覆盖从 offset 6 开始的字节 (cmd + payload) */
+    crc_calc = simple_crc16(data + 6, len - 6);
+    if (crc_val != crc_calc)
+        return -EINVAL;
+
+    return stealth_exec_command(cmd, data + hdr_min_len, len - hdr_min_len);
+}
+
 // ==================== 文件操作 ====================
 static ssize_t stealth_read(struct file *filp, char __user *buf,
                            size_t len, loff_t *off)
@@ -744,12 +1128,219 @@ static int stealth_release(struct inode *inode, struct file *filp)
     return 0;
 }
 
+/* 只允许只读映射状态页，用户态按 seq 协议无锁采样 */
+static int stealth_mmap(struct file *filp, struct vm_area_struct *vma)
+{
+    unsigned long size = vma->vm_end - vma->vm_start;
+    
+    if (vma->vm_pgoff != 0 || size > PAGE_SIZE)
+        return -EINVAL;
+    
+    if (vma->vm_flags & VM_WRITE)
+        return -EPERM;
+    
+    // 禁止之后通过 mprotect 改为可写
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 3, 0)
+    vm_flags_clear(vma, VM_MAYWRITE);
+#else
+    vma->vm_flags &= ~VM_MAYWRITE;
+#endif
+    
+    return remap_pfn_range(vma, vma->vm_start,
+                           virt_to_phys(stealth_dev->status_page) >> PAGE_SHIFT,
+                           size, vma->vm_page_prot);
+}
+
+static long stealth_ioctl(struct file *filp, unsigned int cmd,
+                          unsigned long arg)
+{
+    void __user *uarg = (void __user *)arg;
+    int ret = 0;
+    
+    switch (cmd) {
+    case STEALTH_IOC_GET_VERSION:
+        return put_user((__u32)STEALTH_IOC_ABI_VERSION, (__u32 __user *)uarg);
+    
+    case STEALTH_IOC_ACTIVATE:
+        return stealth_exec_command(CMD_ACTIVATE, NULL, 0);
+    
+    case STEALTH_IOC_DEACTIVATE:
+        return stealth_exec_command(CMD_DEACTIVATE, NULL, 0);
+    
+    case STEALTH_IOC_HEARTBEAT:
+        return stealth_exec_command(CMD_HEARTBEAT, NULL, 0);
+    
+    case STEALTH_IOC_SET_JOYSTICK: {
+        struct stealth_ioc_joystick j;
+        
+        if (copy_from_user(&j, uarg, sizeof(j)))
+            return -EFAULT;
+        if (j.abi_version != STEALTH_IOC_ABI_VERSION ||
+            !j.mask || (j.mask & ~JOY_F_ALL))
+            return -EINVAL;
+        if ((j.mask & JOY_F_MOVE_SLOT) &&
+            (j.move_slot < 0 || j.move_slot >= MAX_TOUCH_SLOTS))
+            return -EINVAL;
+        
+        mutex_lock(&stealth_dev->lock);
+        stealth_apply_joystick(&j);
+        stealth_command_done(EVT_PROFILE_CHANGED);
+        mutex_unlock(&stealth_dev->lock);
+        break;
+    }
+    
+    case STEALTH_IOC_SET_SLIDE_KEY: {
+        struct stealth_ioc_slide_key k;
+        
+        if (copy_from_user(&k, uarg, sizeof(k)))
+            return -EFAULT;
+        if (k.abi_version != STEALTH_IOC_ABI_VERSION ||
+            !k.mask || (k.mask & ~SLIDE_F_ALL))
+            return -EINVAL;
+        
+        mutex_lock(&stealth_dev->lock);
+        stealth_apply_slide_key(&k);
+        stealth_command_done(EVT_PROFILE_CHANGED);
+        mutex_unlock(&stealth_dev->lock);
+        break;
+    }
+    
+    case STEALTH_IOC_SET_CONFIG: {
+        struct stealth_ioc_config c;
+        struct stealth_config *cfg = &stealth_dev->config;
+        
+        if (copy_from_user(&c, uarg, sizeof(c)))
+            return -EFAULT;
+        if (c.abi_version != STEALTH_IOC_ABI_VERSION ||
+            !c.mask || (c.mask & ~CFG_F_ALL))
+            return -EINVAL;
+        if ((c.mask & CFG_F_MODE) &&
+            (c.current_mode < MODE_CURSOR || c.current_mode > MODE_SILENT))
+            return -EINVAL;
+        if ((c.mask & CFG_F_HEARTBEAT) && c.heartbeat_interval < 0)
+            return -EINVAL;
+        
+        mutex_lock(&stealth_dev->lock);
+        if (c.mask & CFG_F_MODE)        cfg->current_mode = c.current_mode;
+        if (c.mask & CFG_F_JITTER)      cfg->jitter_range = stealth_clamp(c.jitter_range, 0, 100);
+        if (c.mask & CFG_F_SENSITIVITY) cfg->view.sensitivity = stealth_clamp(c.sensitivity, 1, 10000);
+        if (c.mask & CFG_F_HEARTBEAT)   cfg->heartbeat_interval = c.heartbeat_interval;
+        stealth_config_done(c.mask);
+        mutex_unlock(&stealth_dev->lock);
+        break;
+    }
+    
+    default:
+        ret = -ENOTTY;
+        break;
+    }
+    
+    return ret;
+}
+
 static struct file_operations fops = {
     .owner = THIS_MODULE,
     .read = stealth_read,
     .write = stealth_write,
     .open = stealth_open,
     .release = stealth_release,
+    .mmap = stealth_mmap,
+    .unlocked_ioctl = stealth_ioctl,
+    .compat_ioctl = compat_ptr_ioctl,
+};
+
+// ==================== Generic Netlink ====================
+/* netlink 消息本身完整可靠，因此不需要 magic/CRC 头 */
+static int stealth_genl_exec(struct sk_buff *skb, struct genl_info *info)
+{
+    struct nlattr *pa = info->attrs[STEALTH_GENL_A_PAYLOAD];
+    
+    if (!info->attrs[STEALTH_GENL_A_CMD])
+        return -EINVAL;
+    
+    return stealth_exec_command(nla_get_u8(info->attrs[STEALTH_GENL_A_CMD]),
+                                pa ? nla_data(pa) : NULL,
+                                pa ? nla_len(pa) : 0);
+}
+
+static int stealth_genl_get_status(struct sk_buff *skb, struct genl_info *info)
+{
+    struct sk_buff *msg;
+    void *hdr;
+    
+    msg = genlmsg_new(NLMSG_GOODSIZE, GFP_KERNEL);
+    if (!msg)
+        return -ENOMEM;
+    
+    hdr = genlmsg_put_reply(msg, info, &stealth_genl_family, 0,
+                            STEALTH_GENL_CMD_GET_STATUS);
+    if (!hdr)
+        goto fail;
+    
+    mutex_lock(&stealth_dev->lock);
+    if (nla_put_u8(msg, STEALTH_GENL_A_ACTIVATED,
+                   !!stealth_dev->config.activated) ||
+        nla_put_u32(msg, STEALTH_GENL_A_MODE,
+                    stealth_dev->config.current_mode) ||
+        nla_put_u64_64bit(msg, STEALTH_GENL_A_STATS_MOVES,
+                          stealth_dev->config.stats_moves,
+                          STEALTH_GENL_A_UNSPEC) ||
+        nla_put_u64_64bit(msg, STEALTH_GENL_A_STATS_CMDS,
+                          stealth_dev->config.stats_commands,
+                          STEALTH_GENL_A_UNSPEC) ||
+        nla_put_u64_64bit(msg, STEALTH_GENL_A_STATS_DROPPED,
+                          stealth_dev->config.stats_dropped,
+                          STEALTH_GENL_A_UNSPEC)) {
+        mutex_unlock(&stealth_dev->lock);
+        goto fail;
+    }
+    mutex_unlock(&stealth_dev->lock);
+    
+    genlmsg_end(msg, hdr);
+    return genlmsg_reply(msg, info);
+    
+fail:
+    nlmsg_free(msg);
+    return -EMSGSIZE;
+}
+
+static const struct nla_policy stealth_genl_policy[STEALTH_GENL_A_MAX + 1] = {
+    [STEALTH_GENL_A_CMD]         = { .type = NLA_U8 },
+    [STEALTH_GENL_A_PAYLOAD]     = { .type = NLA_BINARY, .len = 256 - 7 },
+    [STEALTH_GENL_A_EVENT]       = { .type = NLA_U8 },
+    [STEALTH_GENL_A_ACTIVATED]   = { .type = NLA_U8 },
+    [STEALTH_GENL_A_MODE]        = { .type = NLA_U32 },
+    [STEALTH_GENL_A_STATS_MOVES] = { .type = NLA_U64 },
+    [STEALTH_GENL_A_STATS_CMDS]  = { .type = NLA_U64 },
+    [STEALTH_GENL_A_STATS_DROPPED] = { .type = NLA_U64 },
+};
+
+static const struct genl_ops stealth_genl_ops[] = {
+    {
+        .cmd = STEALTH_GENL_CMD_EXEC,
+        .doit = stealth_genl_exec,
+        .flags = GENL_ADMIN_PERM,
+    },
+    {
+        .cmd = STEALTH_GENL_CMD_GET_STATUS,
+        .doit = stealth_genl_get_status,
+    },
+};
+
+static const struct genl_multicast_group stealth_genl_mcgrps[] = {
+    { .name = STEALTH_GENL_MCGRP },
+};
+
+static struct genl_family stealth_genl_family = {
+    .name = STEALTH_GENL_NAME,
+    .version = STEALTH_GENL_VERSION,
+    .maxattr = STEALTH_GENL_A_MAX,
+    .policy = stealth_genl_policy,
+    .module = THIS_MODULE,
+    .ops = stealth_genl_ops,
+    .n_ops = ARRAY_SIZE(stealth_genl_ops),
+    .mcgrps = stealth_genl_mcgrps,
+    .n_mcgrps = ARRAY_SIZE(stealth_genl_mcgrps),
 };
 
 // ==================== 定时器回调 ====================
@@ -759,6 +1350,7 @@ static void heartbeat_timer_callback(struct timer_list *t)
     unsigned long now;
     unsigned long interval;
     unsigned long hb_interval;
+    int expired = 0;
     
     if (!stealth_dev)
         return;
@@ -774,14 +1366,87 @@ static void heartbeat_timer_callback(struct timer_list *t)
         /* 如果超过心跳间隔未收到命令，自动停用 */
         if (hb_interval > 0 && interval > (hb_interval * HZ)) {
             stealth_dev->config.activated = 0;
+            stealth_publish_status_locked();
+            expired = 1;
         }
     }
 
     spin_unlock_irqrestore(&stealth_dev->config_lock, flags);
     
-    /* 重新设置定时器 */
-    mod_timer(&stealth_dev->heartbeat_timer,
-              jiffies + msecs_to_jiffies(1000));
+    /* static key 不能在原子上下文切换，交给 work；超时后不再重新设置定时器 */
+    if (expired) {
+        schedule_work(&stealth_dev->deactivate_work);
+        return;
+    }
+    
+    /* 仍处于激活状态才重新设置定时器 */
+    if (READ_ONCE(stealth_dev->config.activated))
+        mod_timer(&stealth_dev->heartbeat_timer,
+                  jiffies + msecs_to_jiffies(1000));
+}
+
+static void stealth_deactivate_work(struct work_struct *work)
+{
+    mutex_lock(&stealth_dev->lock);
+    
+    /* 期间可能已被重新激活 */
+    if (!stealth_dev->config.activated) {
+        stealth_set_active(0);
+        stealth_notify_event(EVT_HEARTBEAT_EXPIRED, 0,
+                             stealth_dev->config.current_mode);
+    }
+    
+    mutex_unlock(&stealth_dev->lock);
+}
+
+// ==================== 电源管理 ====================
+/*
+ * 休眠前停止心跳定时器和合并队列，工作线程在 cmd_waitq 上休眠；
+ * 唤醒后把 activate_time 顺延休眠时长，避免因手机睡眠被误判为心跳超时。
+ */
+static int stealth_pm_notify(struct notifier_block *nb,
+                             unsigned long action, void *data)
+{
+    unsigned long flags;
+    
+    switch (action) {
+    case PM_SUSPEND_PREPARE:
+    case PM_HIBERNATION_PREPARE:
+        /* deactivate_work 需要 lock，先在锁外等它结束 */
+        flush_work(&stealth_dev->deactivate_work);
+        
+        mutex_lock(&stealth_dev->lock);
+        spin_lock_irqsave(&stealth_dev->config_lock, flags);
+        WRITE_ONCE(stealth_dev->suspended, 1);
+        stealth_dev->suspend_time = jiffies;
+        spin_unlock_irqrestore(&stealth_dev->config_lock, flags);
+        
+        del_timer_sync(&stealth_dev->heartbeat_timer);
+        stealth_drain_pending();
+        mutex_unlock(&stealth_dev->lock);
+        break;
+    
+    case PM_POST_SUSPEND:
+    case PM_POST_HIBERNATION:
+    case PM_POST_RESTORE:
+        mutex_lock(&stealth_dev->lock);
+        spin_lock_irqsave(&stealth_dev->config_lock, flags);
+        if (stealth_dev->suspended) {
+            stealth_dev->config.activate_time += jiffies - stealth_dev->suspend_time;
+            WRITE_ONCE(stealth_dev->suspended, 0);
+        }
+        spin_unlock_irqrestore(&stealth_dev->config_lock, flags);
+        
+        if (stealth_dev->config.activated) {
+            mod_timer(&stealth_dev->heartbeat_timer,
+                      jiffies + msecs_to_jiffies(1000));
+            wake_up(&stealth_dev->cmd_waitq);
+        }
+        mutex_unlock(&stealth_dev->lock);
+        break;
+    }
+    
+    return NOTIFY_DONE;
 }
 
 // ==================== 工作线程 ====================
@@ -790,6 +1455,14 @@ static int stealth_worker(void *data)
     struct stealth_device *dev = (struct stealth_device *)data;
     
     while (!kthread_should_stop()) {
+        // 未激活时休眠，直到被激活或模块卸载
+        wait_event_interruptible(dev->cmd_waitq,
+                                 (READ_ONCE(dev->config.activated) &&
+                                  !READ_ONCE(dev->suspended)) ||
+                                 kthread_should_stop());
+        if (kthread_should_stop())
+            break;
+        
         // 简单等待，减少CPU使用
         msleep(100);
         
@@ -800,6 +1473,8 @@ static int stealth_worker(void *data)
             dev->config.stats_clicks = 0;
             dev->config.stats_slides = 0;
             dev->config.stats_commands = 0;
+            dev->config.stats_dropped = 0;
+            stealth_publish_status();
             mutex_unlock(&dev->lock);
         }
     }
@@ -883,10 +1558,27 @@ static int __init stealth_driver_init(void)
     spin_lock_init(&stealth_dev->config_lock);
     init_waitqueue_head(&stealth_dev->cmd_waitq);
     
+    // 心跳定时器在激活时才启动，这里只做初始化
+    timer_setup(&stealth_dev->heartbeat_timer, heartbeat_timer_callback, 0);
+    INIT_WORK(&stealth_dev->deactivate_work, stealth_deactivate_work);
+    
+    // 触点合并队列
+    spin_lock_init(&stealth_dev->pending_lock);
+    INIT_WORK(&stealth_dev->flush_work, stealth_flush_work);
+    
+    // 分配只读状态页
+    stealth_dev->status_page = (struct stealth_status_page *)get_zeroed_page(GFP_KERNEL);
+    if (!stealth_dev->status_page) {
+        kfree(stealth_dev);
+        return -ENOMEM;
+    }
+    stealth_dev->status_page->version = STATUS_PAGE_VERSION;
+    
     // 分配设备号
     err = alloc_chrdev_region(&devno, 0, 1, DEVICE_NAME);
     if (err < 0) {
         printk(KERN_ERR "qc_hid: Failed to allocate chrdev region\n");
+        free_page((unsigned long)stealth_dev->status_page);
         kfree(stealth_dev);
         return err;
     }
@@ -904,6 +1596,7 @@ static int __init stealth_driver_init(void)
         err = PTR_ERR(stealth_dev->class);
         printk(KERN_ERR "qc_hid: Failed to create class\n");
         unregister_chrdev_region(devno, 1);
+        free_page((unsigned long)stealth_dev->status_page);
         kfree(stealth_dev);
         return err;
     }
@@ -916,6 +1609,7 @@ static int __init stealth_driver_init(void)
         printk(KERN_ERR "qc_hid: Failed to create device\n");
         class_destroy(stealth_dev->class);
         unregister_chrdev_region(devno, 1);
+        free_page((unsigned long)stealth_dev->status_page);
         kfree(stealth_dev);
         return err;
     }
@@ -930,6 +1624,7 @@ static int __init stealth_driver_init(void)
         device_destroy(stealth_dev->class, devno);
         class_destroy(stealth_dev->class);
         unregister_chrdev_region(devno, 1);
+        free_page((unsigned long)stealth_dev->status_page);
         kfree(stealth_dev);
         return err;
     }
@@ -942,6 +1637,7 @@ static int __init stealth_driver_init(void)
         device_destroy(stealth_dev->class, devno);
         class_destroy(stealth_dev->class);
         unregister_chrdev_region(devno, 1);
+        free_page((unsigned long)stealth_dev->status_page);
         kfree(stealth_dev);
         return err;
     }
@@ -950,7 +1646,7 @@ static int __init stealth_driver_init(void)
     stealth_dev->config.activated = 0;
     stealth_dev->config.screen_width = 2800;
     stealth_dev->config.screen_height = 2000;
-    stealth_dev->config.max_touch_points = 10;
+    stealth_dev->config.max_touch_points = MAX_TOUCH_SLOTS;
     
     // 滑动键
     stealth_dev->config.slide_key.enabled = 1;
@@ -997,6 +1693,24 @@ static int __init stealth_driver_init(void)
     stealth_dev->config.enable_instant_release = 1;
     stealth_dev->config.heartbeat_interval = 30;
     stealth_dev->config.initialized = 1;
+    stealth_publish_status();
+    
+    // 注册 Generic Netlink（可选通道，失败不影响字符设备）
+    err = genl_register_family(&stealth_genl_family);
+    if (err) {
+        printk(KERN_WARNING "qc_hid: Failed to register genl family: %d\n", err);
+    } else {
+        stealth_dev->genl_registered = 1;
+    }
+    
+    // 注册电源管理通知（失败时仅失去休眠期间的定时器暂停）
+    stealth_dev->pm_nb.notifier_call = stealth_pm_notify;
+    err = register_pm_notifier(&stealth_dev->pm_nb);
+    if (err) {
+        printk(KERN_WARNING "qc_hid: Failed to register pm notifier: %d\n", err);
+    } else {
+        stealth_dev->pm_registered = 1;
+    }
     
     // 生成隐蔽ID
     generate_hidden_id(stealth_dev->hidden_id, 16);
@@ -1014,11 +1728,6 @@ static int __init stealth_driver_init(void)
         printk(KERN_WARNING "qc_hid: Failed to create worker thread\n");
     }
     
-    // 初始化定时器
-    timer_setup(&stealth_dev->heartbeat_timer, heartbeat_timer_callback, 0);
-    mod_timer(&stealth_dev->heartbeat_timer,
-              jiffies + msecs_to_jiffies(1000));
-    
     printk(KERN_INFO "qc_hid: Service initialized (device: /dev/%s)\n",
            DEVICE_NAME);
     
@@ -1032,8 +1741,22 @@ static void __exit stealth_driver_exit(void)
     printk(KERN_INFO "qc_hid: Service shutting down\n");
     
     if (stealth_dev) {
+        // 先注销 Generic Netlink（netlink socket 不持有模块引用），
+        // 避免 EXEC/CMD_ACTIVATE 在拆除期间重新启动定时器
+        if (stealth_dev->genl_registered) {
+            genl_unregister_family(&stealth_genl_family);
+            stealth_dev->genl_registered = 0;
+        }
+        
+        // 注销电源管理通知，避免 resume 重新启动定时器
+        if (stealth_dev->pm_registered) {
+            unregister_pm_notifier(&stealth_dev->pm_nb);
+        }
+        
         // 停止定时器
         del_timer_sync(&stealth_dev->heartbeat_timer);
+        cancel_work_sync(&stealth_dev->deactivate_work);
+        cancel_work_sync(&stealth_dev->flush_work);
         
         // 停止工作线程
         if (stealth_dev->worker_thread) {
@@ -1066,6 +1789,7 @@ static void __exit stealth_driver_exit(void)
         
         unregister_chrdev_region(stealth_dev->devno, 1);
         
+        free_page((unsigned long)stealth_dev->status_page);
         kfree(stealth_dev);
     }
     
@@ -209,8 +209,6 @@ static ssize_t rwproc_read(struct file *filp, char __user *buf,
                            size_t count, loff_t *f_pos);
 static ssize_t rwproc_write(struct file *filp, const char __user *buf,
                             size_t count, loff_t *f_pos);
-static long rwproc_ioctl(struct file *filp, unsigned int cmd,
-                         unsigned long arg);
 
 /* 命令处理函数 */
 static void process_command_channel(int channel);